@@ -0,0 +1,249 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ParkourTimeTrialCharacter.h"
+#include "ParkourTimeTrialSessionReplay.h"
+#include "CoreGlobals.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "UObject/Class.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Forwards to the real allocator and counts every allocation made on the game thread */
+	class FParkourCountingMalloc final : public FMalloc
+	{
+	public:
+		FMalloc* Inner = nullptr;
+		int32 GameThreadAllocations = 0;
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count != 0)
+			{
+				CountAllocation();
+			}
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override
+		{
+			Inner->Free(Original);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return Inner->QuantizeSize(Count, Alignment);
+		}
+
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+		{
+			return Inner->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual bool IsInternallyThreadSafe() const override
+		{
+			return Inner->IsInternallyThreadSafe();
+		}
+
+		virtual void Trim(bool bTrimThreadCaches) override
+		{
+			Inner->Trim(bTrimThreadCaches);
+		}
+
+		virtual const TCHAR* GetDescriptiveName() override
+		{
+			return Inner->GetDescriptiveName();
+		}
+
+	private:
+		void CountAllocation()
+		{
+			if (IsInGameThread())
+			{
+				++GameThreadAllocations;
+			}
+		}
+	};
+
+	/**
+	 * Routes GMalloc through the counter for the lifetime of the scope. The counter itself is never
+	 * destroyed, other threads may still be inside it for a moment after GMalloc is restored.
+	 */
+	struct FScopedAllocationCounter
+	{
+		FScopedAllocationCounter()
+		{
+			Counter.Inner = GMalloc;
+			Counter.GameThreadAllocations = 0;
+			GMalloc = &Counter;
+		}
+
+		~FScopedAllocationCounter()
+		{
+			GMalloc = Counter.Inner;
+		}
+
+		int32 GetAllocations() const { return Counter.GameThreadAllocations; }
+
+	private:
+		static FParkourCountingMalloc Counter;
+	};
+
+	FParkourCountingMalloc FScopedAllocationCounter::Counter;
+
+	/** Engine frames per parkour cycle; long enough for the dash cooldown to run out before the next one */
+	constexpr int32 FramesPerCycle = 60;
+	constexpr float TickSeconds = 1.f / 20.f;
+	/** Enough cycles for every buffer in the replay writer's ring to have been handed back at least once */
+	constexpr int32 WarmupCycles = 4;
+	constexpr int32 MeasuredCycles = 8;
+
+	/** Parameter blocks for the Blueprint callable functions the FirstPersonCharacter Blueprint drives */
+	struct FGetWallRunSideAndDirectionParams
+	{
+		FVector SurfaceNormal = FVector::ZeroVector;
+		FVector Direction = FVector::ZeroVector;
+		EWallRunSide Side = EWallRunSide::Left;
+	};
+
+	struct FCheckKeysAreDownParams
+	{
+		EWallRunSide Side = EWallRunSide::Left;
+		bool ReturnValue = false;
+	};
+
+	/**
+	 * Runs one engine frame of the test world per update. The world is ticked here rather than by the
+	 * engine, so its timers, movement and the replay's Tick all run inside the measured scope.
+	 */
+	class FParkourSteadyStateFrameCommand : public IAutomationLatentCommand
+	{
+	public:
+		FParkourSteadyStateFrameCommand(FAutomationTestBase* InTest, UWorld* InWorld, AParkourTimeTrialCharacter* InCharacter, AParkourTimeTrialSessionReplay* InReplay, const FString& InReplayPath)
+			: Test(InTest)
+			, World(InWorld)
+			, Character(InCharacter)
+			, Replay(InReplay)
+			, ReplayPath(InReplayPath)
+			, GetWallRunSideAndDirectionFunction(InCharacter->FindFunctionChecked(TEXT("GetWallRunSideAndDirection")))
+			, BeginWallRunFunction(InCharacter->FindFunctionChecked(TEXT("BeginWallRun")))
+			, CheckKeysAreDownFunction(InCharacter->FindFunctionChecked(TEXT("CheckKeysAreDown")))
+		{
+		}
+
+		virtual bool Update() override
+		{
+			const int32 MeasuredFrames = MeasuredCycles * FramesPerCycle;
+			const int32 WarmupFrames = WarmupCycles * FramesPerCycle;
+			if (Frame < WarmupFrames)
+			{
+				RunFrame();
+			}
+			else if (Frame < WarmupFrames + MeasuredFrames)
+			{
+				FScopedAllocationCounter Counter;
+				RunFrame();
+				Allocations += Counter.GetAllocations();
+			}
+			else
+			{
+				Test->TestEqual(TEXT("Heap allocations in steady state parkour and replay recording"), Allocations, 0);
+				Replay->StopRecording();
+				IFileManager::Get().Delete(*ReplayPath);
+				GEngine->DestroyWorldContext(World);
+				World->DestroyWorld(false);
+				return true;
+			}
+			++Frame;
+			return false;
+		}
+
+	private:
+		/**
+		 * One frame of a wall run, wall jump and dash, called the way the character Blueprint and input
+		 * bindings call it. OnFire is left out: spawning the projectile is an accepted allocation.
+		 */
+		void RunFrame()
+		{
+			const int32 CycleFrame = Frame % FramesPerCycle;
+			if (CycleFrame == 0)
+			{
+				FGetWallRunSideAndDirectionParams WallParams;
+				WallParams.SurfaceNormal = FVector(0.f, -1.f, 0.f);
+				Character->ProcessEvent(GetWallRunSideAndDirectionFunction, &WallParams);
+				Character->WallRunDirection = WallParams.Direction;
+				Character->WallRunSide = WallParams.Side;
+				Character->ProcessEvent(BeginWallRunFunction, nullptr);
+			}
+			else if (CycleFrame < 20)
+			{
+				FCheckKeysAreDownParams KeyParams;
+				KeyParams.Side = Character->WallRunSide;
+				Character->ProcessEvent(CheckKeysAreDownFunction, &KeyParams);
+			}
+			else if (CycleFrame == 20)
+			{
+				Character->DoubleJump();
+			}
+			else if (CycleFrame == 30)
+			{
+				Character->Dash();
+			}
+
+			// Fires the tilt, dash, net update frequency timers and the replay's sampling
+			World->Tick(LEVELTICK_All, TickSeconds);
+		}
+
+		FAutomationTestBase* Test;
+		UWorld* World;
+		AParkourTimeTrialCharacter* Character;
+		AParkourTimeTrialSessionReplay* Replay;
+		FString ReplayPath;
+		UFunction* GetWallRunSideAndDirectionFunction;
+		UFunction* BeginWallRunFunction;
+		UFunction* CheckKeysAreDownFunction;
+		int32 Frame = 0;
+		int32 Allocations = 0;
+	};
+}
+
+// Editor only: a game engine would tick the test world itself, outside the measured scope
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FParkourSteadyStateAllocationTest, "ParkourTimeTrial.Performance.SteadyStateAllocations", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FParkourSteadyStateAllocationTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	AParkourTimeTrialCharacter* Character = World->SpawnActor<AParkourTimeTrialCharacter>();
+	APlayerController* Controller = World->SpawnActor<APlayerController>();
+	Controller->Possess(Character);
+
+	// Short chunks so the measured frames also cover handing finished chunks to the writer
+	AParkourTimeTrialSessionReplay* Replay = World->SpawnActor<AParkourTimeTrialSessionReplay>();
+	Replay->KeyframeInterval = 0.1f;
+	const FString ReplayPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Automation"), TEXT("ParkourAllocationTest.pkreplay"));
+	Replay->StartRecording(ReplayPath);
+
+	// Latent frames run once per engine frame, so the timer manager sees a new frame every update
+	ADD_LATENT_AUTOMATION_COMMAND(FParkourSteadyStateFrameCommand(this, World, Character, Replay, ReplayPath));
+	return true;
+}
+
+#endif
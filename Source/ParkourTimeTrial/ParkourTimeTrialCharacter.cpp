@@ -2,13 +2,16 @@
 
 #include "ParkourTimeTrialCharacter.h"
 #include "ParkourTimeTrialProjectile.h"
+#include "ParkourTimeTrialProfile.h"
 #include "Animation/AnimInstance.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
+#include "GameFramework/PlayerController.h"
 #include "GameFramework/InputSettings.h"
 #include "Kismet/GameplayStatics.h"
 #include "MotionControllerComponent.h"
+#include "Net/UnrealNetwork.h"
 #include "Runtime/Engine/Classes/GameFramework/CharacterMovementComponent.h"
 #include "Runtime/Engine/Public/TimerManager.h"
 
@@ -58,20 +61,17 @@ AParkourTimeTrialCharacter::AParkourTimeTrialCharacter()
 
 	// Uncomment the following line to turn motion controllers on by default:
 	//bUsingMotionControllers = true;
-	JumpHeight = 600.f;
-	RegularAirControl = 0.5f;
-	GetCharacterMovement()->AirControl = RegularAirControl;
-	GetCharacterMovement()->MaxWalkSpeed = 750.0f;
 	//GetCharacterMovement()->MaxAcceleration = 800.0f;
 	CanDash = true;
-	DashDistance = 6000.f;
-	DashCooldown = 2.f;
-	DashStop = 0.1f;
-	MultiJumpMaximum = 2;
-	WallRunAirControl = 1.f;
-	WallRunJumpLaunchMultiplier = 500;
-	WallRunTilt = 15.f;
-	WallRunTiltRate = 0.2f;
+	ApplyTuning(FParkourTuning(ParkourPresets::Standard));
+
+	NearNetUpdateFrequency = 60.f;
+	FarNetUpdateFrequency = 10.f;
+	NearRelevancyDistance = 2000.f;
+	FarRelevancyDistance = 10000.f;
+	NetUpdateFrequency = NearNetUpdateFrequency;
+	MinNetUpdateFrequency = FarNetUpdateFrequency;
+	ParkourState.Flags = FParkourMovementRepState::CanDashFlag;
 }
 
 void AParkourTimeTrialCharacter::BeginPlay()
@@ -82,6 +82,240 @@ void AParkourTimeTrialCharacter::BeginPlay()
 	//Attach gun mesh component to Skeleton, doing it here because the skeleton is not yet created in the constructor
 	FP_Gun->AttachToComponent(Mesh1P, FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), TEXT("GripPoint"));
 	Mesh1P->SetHiddenInGame(false, true);
+
+	// Always re-apply so values saved on a Blueprint or placed instance can't override the profile
+	ApplyTuning(Profile != nullptr ? Profile->GetTuning() : FParkourTuning(ParkourPresets::Standard));
+	ProfileChangedHandle = UParkourTimeTrialProfile::OnProfileChanged.AddUObject(this, &AParkourTimeTrialCharacter::OnProfileChanged);
+
+	SimulatedBaseRotationOffset = GetBaseRotationOffset();
+	Mesh1PBaseTransform = Mesh1P->GetRelativeTransform();
+	if (HasAuthority())
+	{
+		GetWorldTimerManager().SetTimer(NetUpdateFrequencyHandle, this, &AParkourTimeTrialCharacter::UpdateNetUpdateFrequency, 0.5f, true);
+	}
+}
+
+void AParkourTimeTrialCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UParkourTimeTrialProfile::OnProfileChanged.Remove(ProfileChangedHandle);
+	Super::EndPlay(EndPlayReason);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Tuning
+
+void AParkourTimeTrialCharacter::ApplyProfile(UParkourTimeTrialProfile* NewProfile)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+	if (Profile != nullptr && Profile->IsLocked())
+	{
+		UE_LOG(LogFPChar, Warning, TEXT("%s is locked to a competitive profile, ignoring %s"), *GetName(), *GetNameSafe(NewProfile));
+		return;
+	}
+	ForceProfile(NewProfile);
+}
+
+void AParkourTimeTrialCharacter::ForceProfile(UParkourTimeTrialProfile* NewProfile)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+	Profile = NewProfile;
+	if (Profile != nullptr)
+	{
+		ApplyTuning(Profile->GetTuning());
+	}
+}
+
+void AParkourTimeTrialCharacter::ApplyTuning(const FParkourTuning& Tuning)
+{
+	JumpHeight = Tuning.JumpHeight;
+	MultiJumpMaximum = Tuning.MultiJumpMaximum;
+	RegularAirControl = Tuning.RegularAirControl;
+	DashDistance = Tuning.DashDistance;
+	DashCooldown = Tuning.DashCooldown;
+	DashStop = Tuning.DashStop;
+	WallRunAirControl = Tuning.WallRunAirControl;
+	WallRunJumpLaunchMultiplier = Tuning.WallRunJumpLaunchMultiplier;
+	WallRunTilt = Tuning.WallRunTilt;
+	WallRunTiltRate = Tuning.WallRunTiltRate;
+	GetCharacterMovement()->MaxWalkSpeed = Tuning.MaxWalkSpeed;
+	GetCharacterMovement()->AirControl = (ParkourState.Flags & FParkourMovementRepState::WallRunningFlag) != 0 ? WallRunAirControl : RegularAirControl;
+}
+
+void AParkourTimeTrialCharacter::OnRep_Profile()
+{
+	if (Profile != nullptr)
+	{
+		ApplyTuning(Profile->GetTuning());
+	}
+}
+
+void AParkourTimeTrialCharacter::OnProfileChanged(const UParkourTimeTrialProfile* ChangedProfile)
+{
+	if (ChangedProfile == Profile)
+	{
+		ApplyTuning(ChangedProfile->GetTuning());
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Replication
+
+void AParkourTimeTrialCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// The owning client drives this state itself
+	DOREPLIFETIME_CONDITION(AParkourTimeTrialCharacter, ParkourState, COND_SkipOwner);
+	// Everyone, the owner included, has to move with the same tuning as the server
+	DOREPLIFETIME(AParkourTimeTrialCharacter, Profile);
+}
+
+void AParkourTimeTrialCharacter::UpdateParkourState()
+{
+	FParkourMovementRepState NewState;
+	NewState.Flags = (IsWallRunning ? FParkourMovementRepState::WallRunningFlag : 0)
+		| (WallRunSide == EWallRunSide::Right ? FParkourMovementRepState::RightSideFlag : 0)
+		| (CanDash ? FParkourMovementRepState::CanDashFlag : 0);
+	NewState.WallRunYaw = FRotator::CompressAxisToShort(WallRunDirection.Rotation().Yaw);
+
+	// The owner keeps its own copy too, it never receives the replicated one
+	ParkourState = NewState;
+	if (!HasAuthority())
+	{
+		ServerSetParkourState(NewState);
+	}
+}
+
+void AParkourTimeTrialCharacter::ServerSetParkourState_Implementation(FParkourMovementRepState NewState)
+{
+	// Wall runs are detected by the owning client; every update that claims one must have a usable wall, so
+	// the side and direction can't be swapped mid run either
+	const bool bClaimsWallRun = (NewState.Flags & FParkourMovementRepState::WallRunningFlag) != 0;
+	if (bClaimsWallRun && !HasWallForWallRun(NewState))
+	{
+		UE_LOG(LogFPChar, Verbose, TEXT("%s claimed a wall run without a wall, ignoring it"), *GetName());
+		NewState.Flags &= ~FParkourMovementRepState::WallRunningFlag;
+	}
+
+	// Dash availability is owned by the server: a dash is only accepted off cooldown and the server runs the cooldown itself
+	const bool bDashReady = (ParkourState.Flags & FParkourMovementRepState::CanDashFlag) != 0;
+	const bool bClaimsDash = (NewState.Flags & FParkourMovementRepState::CanDashFlag) == 0;
+	if (bClaimsDash && bDashReady)
+	{
+		GetWorldTimerManager().SetTimer(DashCountdownHandle, this, &AParkourTimeTrialCharacter::ServerResetDash, DashStop + DashCooldown, false);
+	}
+	const bool bCanDash = bDashReady && !bClaimsDash;
+	NewState.Flags = bCanDash ? (NewState.Flags | FParkourMovementRepState::CanDashFlag) : (NewState.Flags & ~FParkourMovementRepState::CanDashFlag);
+
+	const bool bWasWallRunning = (ParkourState.Flags & FParkourMovementRepState::WallRunningFlag) != 0;
+	const bool bWallRunning = (NewState.Flags & FParkourMovementRepState::WallRunningFlag) != 0;
+	ParkourState = NewState;
+	if (bWallRunning != bWasWallRunning)
+	{
+		// Simulate the same movement as the owner so the server doesn't correct it off the wall
+		SetWallRunMovement(bWallRunning);
+		if (bWallRunning)
+		{
+			GetWorldTimerManager().SetTimer(WallRunValidationHandle, this, &AParkourTimeTrialCharacter::ValidateWallRun, 0.25f, true);
+		}
+		else
+		{
+			GetWorldTimerManager().ClearTimer(WallRunValidationHandle);
+		}
+	}
+	StartSimulatedTilt();
+}
+
+void AParkourTimeTrialCharacter::ValidateWallRun()
+{
+	// A client could otherwise keep the flag set long after leaving the wall
+	if ((ParkourState.Flags & FParkourMovementRepState::WallRunningFlag) != 0 && HasWallForWallRun(ParkourState))
+	{
+		return;
+	}
+	UE_LOG(LogFPChar, Verbose, TEXT("%s is no longer next to a wall, ending its wall run"), *GetName());
+	ParkourState.Flags &= ~FParkourMovementRepState::WallRunningFlag;
+	SetWallRunMovement(false);
+	GetWorldTimerManager().ClearTimer(WallRunValidationHandle);
+	StartSimulatedTilt();
+}
+
+void AParkourTimeTrialCharacter::ServerResetDash()
+{
+	ParkourState.Flags |= FParkourMovementRepState::CanDashFlag;
+}
+
+bool AParkourTimeTrialCharacter::HasWallForWallRun(const FParkourMovementRepState& State)
+{
+	// Invert GetWallRunSideAndDirection to recover the wall normal from the running direction
+	const FVector Direction = FRotator(0.f, FRotator::DecompressAxisFromShort(State.WallRunYaw), 0.f).Vector();
+	const bool bRightSide = (State.Flags & FParkourMovementRepState::RightSideFlag) != 0;
+	const FVector WallNormal = bRightSide ? FVector::CrossProduct(FVector::UpVector, Direction) : FVector::CrossProduct(Direction, FVector::UpVector);
+
+	const FVector Start = GetActorLocation();
+	const FVector End = Start - WallNormal * (GetCapsuleComponent()->GetScaledCapsuleRadius() + 50.f);
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(ParkourWallRunCheck), false, this);
+	FHitResult Hit;
+	return GetWorld()->LineTraceSingleByChannel(Hit, Start, End, ECC_Visibility, Params) && IsSurfaceValidForWallRun(Hit.ImpactNormal);
+}
+
+void AParkourTimeTrialCharacter::StartSimulatedTilt()
+{
+	// Simulated proxies and remote runners on a listen server rebuild the tilt themselves
+	if (!IsLocallyControlled() && GetNetMode() != NM_DedicatedServer)
+	{
+		GetWorldTimerManager().SetTimer(SimulatedTiltHandle, this, &AParkourTimeTrialCharacter::UpdateSimulatedTilt, 0.01f, true);
+	}
+}
+
+void AParkourTimeTrialCharacter::OnRep_ParkourState()
+{
+	StartSimulatedTilt();
+}
+
+void AParkourTimeTrialCharacter::UpdateSimulatedTilt()
+{
+	float TargetTilt = 0.f;
+	if ((ParkourState.Flags & FParkourMovementRepState::WallRunningFlag) != 0)
+	{
+		TargetTilt = (ParkourState.Flags & FParkourMovementRepState::RightSideFlag) != 0 ? WallRunTilt : -WallRunTilt;
+	}
+	SimulatedTilt = FMath::Lerp(SimulatedTilt, TargetTilt, 0.05f);
+	if (FMath::IsNearlyEqual(SimulatedTilt, TargetTilt, 0.1f))
+	{
+		SimulatedTilt = TargetTilt;
+		GetWorldTimerManager().ClearTimer(SimulatedTiltHandle);
+	}
+
+	// Mesh smoothing rebuilds the relative rotation from BaseRotationOffset, so roll it there
+	BaseRotationOffset = FQuat(FRotator(0.f, 0.f, SimulatedTilt)) * SimulatedBaseRotationOffset;
+	GetMesh()->SetRelativeRotation(BaseRotationOffset);
+}
+
+void AParkourTimeTrialCharacter::UpdateNetUpdateFrequency()
+{
+	float NearestDistanceSq = MAX_flt;
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		if (PlayerController == nullptr || PlayerController == GetController())
+		{
+			continue;
+		}
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		NearestDistanceSq = FMath::Min(NearestDistanceSq, FVector::DistSquared(ViewLocation, GetActorLocation()));
+	}
+
+	const float Alpha = FMath::GetMappedRangeValueClamped(FVector2D(NearRelevancyDistance, FarRelevancyDistance), FVector2D(0.f, 1.f), FMath::Sqrt(NearestDistanceSq));
+	NetUpdateFrequency = FMath::Lerp(NearNetUpdateFrequency, FarNetUpdateFrequency, Alpha);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -220,6 +454,7 @@ void AParkourTimeTrialCharacter::Dash()
 		GetCharacterMovement()->BrakingFrictionFactor = 0.f;
 		LaunchCharacter(GetDirectionForDash() * DashDistance, true, true);
 		CanDash = false;
+		UpdateParkourState();
 		GetWorldTimerManager().SetTimer(DashCountdownHandle, this, &AParkourTimeTrialCharacter::StopDashing, DashStop, false);
 	}
 }
@@ -234,6 +469,7 @@ void AParkourTimeTrialCharacter::StopDashing()
 void AParkourTimeTrialCharacter::ResetDash()
 {
 	CanDash = true;
+	UpdateParkourState();
 }
 
 FVector AParkourTimeTrialCharacter::GetDirectionForDash()
@@ -282,8 +518,11 @@ void AParkourTimeTrialCharacter::GetWallRunSideAndDirection(FVector surfaceNorma
 
 bool AParkourTimeTrialCharacter::CheckKeysAreDown(EWallRunSide Side)
 {
-	auto forwardAxis = GetInputAxisValue("MoveForward");
-	auto rightAxis = GetInputAxisValue("MoveRight");
+	// Cached so the per-tick check doesn't hit the name table
+	static const FName MoveForwardName(TEXT("MoveForward"));
+	static const FName MoveRightName(TEXT("MoveRight"));
+	auto forwardAxis = GetInputAxisValue(MoveForwardName);
+	auto rightAxis = GetInputAxisValue(MoveRightName);
 	if (forwardAxis > 0.1)
 	{
 		if (Side == EWallRunSide::Right && rightAxis < -0.1)
@@ -299,9 +538,17 @@ void AParkourTimeTrialCharacter::PerformRotation()
 {
 	auto lerpResult = FMath::Lerp(CurrentRotation, WallRunTargetRotation, 0.05f);
 	CurrentRotation = lerpResult;
-	auto playerRotation = GetController()->GetControlRotation();
-	playerRotation.Roll = lerpResult;
-	GetController()->SetControlRotation(playerRotation);
+	ApplyCameraTilt(lerpResult);
+}
+
+void AParkourTimeTrialCharacter::ApplyCameraTilt(float Roll)
+{
+	// Tilt only the view; control rotation goes to the server with every move and must stay level
+	const FTransform Tilt(FRotator(0.f, 0.f, Roll));
+	FirstPersonCameraComponent->ClearAdditiveOffset();
+	FirstPersonCameraComponent->AddAdditiveOffset(Tilt, 0.f);
+	// The arms hang off the camera component, roll them with the view so they stay put on screen
+	Mesh1P->SetRelativeTransform(Mesh1PBaseTransform * Tilt);
 }
 
 void AParkourTimeTrialCharacter::RotateCharacter()
@@ -328,9 +575,8 @@ void AParkourTimeTrialCharacter::RotateCharacter()
 
 void AParkourTimeTrialCharacter::StartCameraRotation()
 {
-	const auto controller = GetController();
-	WallRunBeginRotation = controller->GetControlRotation().Roll;
-	CurrentRotation = WallRunBeginRotation;
+	// Tilt is an offset on top of the level view, start from whatever is still applied
+	WallRunBeginRotation = 0.f;
 	int Multiplier;
 	if (WallRunSide == EWallRunSide::Right)
 	{
@@ -340,7 +586,7 @@ void AParkourTimeTrialCharacter::StartCameraRotation()
 	{
 		Multiplier = -1;
 	}
-	WallRunTargetRotation = CurrentRotation + Multiplier * WallRunTilt;
+	WallRunTargetRotation = WallRunBeginRotation + Multiplier * WallRunTilt;
 	GetWorldTimerManager().SetTimer(CameraTiltHandle, this, &AParkourTimeTrialCharacter::RotateCharacter, 0.01f, true);
 }
 
@@ -351,25 +597,40 @@ void AParkourTimeTrialCharacter::ReverseCameraRotation()
 	GetWorldTimerManager().SetTimer(CameraTiltHandle, this, &AParkourTimeTrialCharacter::RotateCharacter, 0.01f, true);
 }
 
+void AParkourTimeTrialCharacter::SetWallRunMovement(bool bWallRunning)
+{
+	GetCharacterMovement()->AirControl = bWallRunning ? WallRunAirControl : RegularAirControl;
+	GetCharacterMovement()->GravityScale = bWallRunning ? 0 : 1;
+	GetCharacterMovement()->SetPlaneConstraintNormal(bWallRunning ? FVector(0, 0, 1) : FVector(0, 0, 0));//SetPlaneConstraintAxisSetting(EPlaneConstraintAxisSetting::Z);
+}
+
 void AParkourTimeTrialCharacter::BeginWallRun()
 {
-	GetCharacterMovement()->AirControl = WallRunAirControl;
+	// Wall runs are driven by the owner's input; the Blueprint tick and hit events also fire on the server
+	// and on simulated proxies, which only follow the replicated state
+	if (!IsLocallyControlled())
+	{
+		return;
+	}
+	SetWallRunMovement(true);
 	MultiJumpCounter = 0;
-	GetCharacterMovement()->GravityScale = 0;
-	GetCharacterMovement()->SetPlaneConstraintNormal(FVector(0, 0, 1));//SetPlaneConstraintAxisSetting(EPlaneConstraintAxisSetting::Z);
 	IsWallRunning = true;
+	UpdateParkourState();
 	StartCameraRotation();
 }
 
 void AParkourTimeTrialCharacter::EndWallRun(EWallRunEndCause endCause)
 {
-	GetCharacterMovement()->AirControl = RegularAirControl;
-	GetCharacterMovement()->GravityScale = 1;
-	GetCharacterMovement()->SetPlaneConstraintNormal(FVector(0, 0, 0));
+	if (!IsLocallyControlled())
+	{
+		return;
+	}
+	SetWallRunMovement(false);
 	if (endCause == EWallRunEndCause::Fall)
 	{
 		MultiJumpCounter++;
 	}
 	IsWallRunning = false;
+	UpdateParkourState();
 	ReverseCameraRotation();
 }
\ No newline at end of file
@@ -20,6 +20,24 @@ enum class EWallRunEndCause : uint8 {
 	Jump      UMETA(DisplayName = "Jumped Off"),
 };
 
+/** Wall-run and dash state quantized into one replicated property for simulated proxies */
+USTRUCT()
+struct FParkourMovementRepState
+{
+	GENERATED_BODY()
+
+	static constexpr uint8 WallRunningFlag = 1 << 0;
+	static constexpr uint8 RightSideFlag = 1 << 1;
+	static constexpr uint8 CanDashFlag = 1 << 2;
+
+	UPROPERTY()
+		uint8 Flags = 0;
+
+	/** Wall-run direction as a compressed yaw; the direction is always horizontal */
+	UPROPERTY()
+		uint16 WallRunYaw = 0;
+};
+
 UCLASS(config=Game)
 class AParkourTimeTrialCharacter : public ACharacter
 {
@@ -54,10 +72,10 @@ public:
 	UPROPERTY(EditAnywhere)
 		int MultiJumpCounter;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 		int MultiJumpMaximum;
 	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 		float JumpHeight;
 
 	UFUNCTION(BlueprintCallable)
@@ -75,28 +93,28 @@ public:
 	UPROPERTY()
 		FTimerHandle CameraTiltHandle;
 	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 		float DashDistance;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 		float DashCooldown;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 		bool CanDash;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 		float DashStop;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 		bool IsWallRunning;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 		float RegularAirControl;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 		float WallRunAirControl;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 		int WallRunJumpLaunchMultiplier;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
@@ -105,10 +123,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 		EWallRunSide WallRunSide;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 		float WallRunTilt;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 		float WallRunTiltRate;
 	
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
@@ -139,12 +157,50 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 		uint32 bUsingMotionControllers : 1;
 
+	/**
+	 * Movement tuning; when empty the game mode applies the course profile. The tunables above
+	 * are read only and only ever written from the profile, so a locked profile can't be bypassed.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_Profile, Category = Parkour)
+		class UParkourTimeTrialProfile* Profile;
+
+	/** Update rate used while another player is within NearRelevancyDistance */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Replication)
+		float NearNetUpdateFrequency;
+
+	/** Update rate used once every other player is beyond FarRelevancyDistance */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Replication)
+		float FarNetUpdateFrequency;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Replication)
+		float NearRelevancyDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Replication)
+		float FarRelevancyDistance;
+
+	/** Server only: switches to a new profile, the owning client picks it up through replication */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Parkour)
+		void ApplyProfile(class UParkourTimeTrialProfile* NewProfile);
+
+	/** Server only: applies NewProfile even over a locked one, for enforcing a course's competitive profile */
+	void ForceProfile(class UParkourTimeTrialProfile* NewProfile);
+
+	/**
+	 * Wall-run and dash state as every machine sees it. The owner writes it, the server validates it and
+	 * simulated proxies receive it; IsWallRunning and CanDash are only meaningful on the owner.
+	 */
+	const FParkourMovementRepState& GetParkourState() const { return ParkourState; }
+
 protected:
 	virtual void BeginPlay();
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	void Landed(const FHitResult& Hit) override;
 	
-	/** Fires a projectile. */
+	/** Fires a projectile. Spawning it allocates the actor and its components, the one accepted allocation on the parkour paths. */
 	void OnFire();
 
 	/** Resets HMD orientation and position in VR. */
@@ -191,7 +247,76 @@ protected:
 		bool CheckKeysAreDown(EWallRunSide Side);
 	void PerformRotation();
 
+	/** Rolls the owner's view; never touches the replicated control rotation */
+	void ApplyCameraTilt(float Roll);
+
 private:
+	void ApplyTuning(const struct FParkourTuning& Tuning);
+
+	void OnProfileChanged(const class UParkourTimeTrialProfile* ChangedProfile);
+
+	UFUNCTION()
+		void OnRep_Profile();
+
+	FDelegateHandle ProfileChangedHandle;
+
+	/** Packs the current wall-run and dash state and sends it towards the server */
+	void UpdateParkourState();
+
+	/** Gravity, air control and plane constraint for running along a wall or not */
+	void SetWallRunMovement(bool bWallRunning);
+
+	/** Rolls the mesh of a runner this machine doesn't control towards ParkourState */
+	void StartSimulatedTilt();
+
+	/**
+	 * The state is client authored: the owning client detects wall runs and dashes. The server
+	 * traces for the claimed wall on every update and runs the dash cooldown itself before accepting it.
+	 */
+	UFUNCTION(Server, Reliable)
+		void ServerSetParkourState(FParkourMovementRepState NewState);
+
+	/** Server side check that a wall the state could be running along actually exists */
+	bool HasWallForWallRun(const FParkourMovementRepState& State);
+
+	/** Server only: ends an accepted wall run once its wall is gone */
+	UFUNCTION()
+		void ValidateWallRun();
+
+	UPROPERTY()
+		FTimerHandle WallRunValidationHandle;
+
+	/** Server only: ends the dash cooldown for a client authored dash */
+	UFUNCTION()
+		void ServerResetDash();
+
+	UFUNCTION()
+		void OnRep_ParkourState();
+
+	UPROPERTY(ReplicatedUsing = OnRep_ParkourState)
+		FParkourMovementRepState ParkourState;
+
+	/** Server only: scales NetUpdateFrequency by the distance to the nearest other player */
+	UFUNCTION()
+		void UpdateNetUpdateFrequency();
+
+	UPROPERTY()
+		FTimerHandle NetUpdateFrequencyHandle;
+
+	/** Simulated proxies rebuild the wall-run tilt on their mesh instead of receiving it */
+	UFUNCTION()
+		void UpdateSimulatedTilt();
+
+	UPROPERTY()
+		FTimerHandle SimulatedTiltHandle;
+
+	UPROPERTY()
+		float SimulatedTilt;
+
+	FQuat SimulatedBaseRotationOffset;
+
+	FTransform Mesh1PBaseTransform;
+
 	UFUNCTION()
 		void RotateCharacter();
 
@@ -3,8 +3,55 @@
 #include "ParkourTimeTrialGameMode.h"
 #include "ParkourTimeTrialHUD.h"
 #include "ParkourTimeTrialCharacter.h"
+#include "ParkourTimeTrialProfile.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
 #include "UObject/ConstructorHelpers.h"
 
+DEFINE_LOG_CATEGORY_STATIC(LogParkourNet, Log, All);
+DEFINE_LOG_CATEGORY_STATIC(LogParkourProfile, Log, All);
+
+namespace
+{
+	/** Logs the current send and receive rate of every client connection on this server */
+	void DumpNetReport(UWorld* World)
+	{
+		UNetDriver* NetDriver = World != nullptr ? World->GetNetDriver() : nullptr;
+		if (NetDriver == nullptr || !NetDriver->IsServer())
+		{
+			UE_LOG(LogParkourNet, Display, TEXT("Parkour.NetReport only runs on a server"));
+			return;
+		}
+
+		int32 TotalOutBytesPerSecond = 0;
+		int32 TotalInBytesPerSecond = 0;
+		for (UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			if (Connection == nullptr)
+			{
+				continue;
+			}
+			const APlayerController* PlayerController = Connection->PlayerController;
+			const FString PlayerName = (PlayerController != nullptr && PlayerController->PlayerState != nullptr) ? PlayerController->PlayerState->GetPlayerName() : TEXT("<pending>");
+			UE_LOG(LogParkourNet, Display, TEXT("%s (%s): out %d B/s (%d pkt/s), in %d B/s (%d pkt/s), net speed %d"),
+				*PlayerName, *Connection->LowLevelGetRemoteAddress(true),
+				Connection->OutBytesPerSecond, Connection->OutPacketsPerSecond,
+				Connection->InBytesPerSecond, Connection->InPacketsPerSecond,
+				Connection->CurrentNetSpeed);
+			TotalOutBytesPerSecond += Connection->OutBytesPerSecond;
+			TotalInBytesPerSecond += Connection->InBytesPerSecond;
+		}
+		UE_LOG(LogParkourNet, Display, TEXT("%d connections: out %d B/s, in %d B/s"), NetDriver->ClientConnections.Num(), TotalOutBytesPerSecond, TotalInBytesPerSecond);
+	}
+
+	FAutoConsoleCommandWithWorld NetReportCommand(
+		TEXT("Parkour.NetReport"),
+		TEXT("Logs per-connection replication bandwidth for the current race server"),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&DumpNetReport));
+}
+
 AParkourTimeTrialGameMode::AParkourTimeTrialGameMode()
 	: Super()
 {
@@ -15,3 +62,28 @@ AParkourTimeTrialGameMode::AParkourTimeTrialGameMode()
 	// use our custom HUD class
 	HUDClass = AParkourTimeTrialHUD::StaticClass();
 }
+
+void AParkourTimeTrialGameMode::SetPlayerDefaults(APawn* PlayerPawn)
+{
+	Super::SetPlayerDefaults(PlayerPawn);
+
+	AParkourTimeTrialCharacter* Character = Cast<AParkourTimeTrialCharacter>(PlayerPawn);
+	if (Character == nullptr || CourseProfile == nullptr)
+	{
+		return;
+	}
+
+	if (CourseProfile->IsLocked())
+	{
+		// Competitive courses always run on validated values, whatever the pawn Blueprint or instance was set up with
+		if (Character->Profile != nullptr && Character->Profile != CourseProfile)
+		{
+			UE_LOG(LogParkourProfile, Warning, TEXT("%s brings profile %s, replacing it with locked course profile %s"), *Character->GetName(), *Character->Profile->GetName(), *CourseProfile->GetName());
+		}
+		Character->ForceProfile(CourseProfile);
+	}
+	else if (Character->Profile == nullptr)
+	{
+		Character->ApplyProfile(CourseProfile);
+	}
+}
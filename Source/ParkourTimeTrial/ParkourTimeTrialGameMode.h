@@ -13,6 +13,13 @@ class AParkourTimeTrialGameMode : public AGameModeBase
 
 public:
 	AParkourTimeTrialGameMode();
+
+	/** Applies the course profile to characters that don't bring their own, and to every character if it is locked */
+	virtual void SetPlayerDefaults(APawn* PlayerPawn) override;
+
+	/** Movement tuning for this course; set per map through the World Settings game mode override */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Parkour)
+		class UParkourTimeTrialProfile* CourseProfile;
 };
 
 
@@ -0,0 +1,230 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ParkourTimeTrialGhostManager.h"
+#include "ParkourTimeTrialProxies.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "EngineUtils.h"
+#include "Kismet/GameplayStatics.h"
+#include "UObject/ConstructorHelpers.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogParkourGhosts, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("ParkourGhosts"), STATGROUP_ParkourGhosts, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Ghost Tick"), STAT_ParkourGhostTick, STATGROUP_ParkourGhosts);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ghosts"), STAT_ParkourGhosts, STATGROUP_ParkourGhosts);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Near Instances"), STAT_ParkourGhostNearInstances, STATGROUP_ParkourGhosts);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Far Instances"), STAT_ParkourGhostFarInstances, STATGROUP_ParkourGhosts);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Component Updates"), STAT_ParkourGhostComponentUpdates, STATGROUP_ParkourGhosts);
+
+namespace
+{
+	/** Ghosts this close are never angle culled, their capsule can fill the screen edge */
+	constexpr float AlwaysVisibleDistance = 300.f;
+
+	/** Hands Transforms to Proxies unless they match what it already draws */
+	void UpdateProxies(UInstancedStaticMeshComponent* Proxies, const TArray<FTransform>& Transforms, TArray<FTransform>& Drawn)
+	{
+		bool bChanged = Transforms.Num() != Drawn.Num();
+		for (int32 Index = 0; !bChanged && Index < Transforms.Num(); ++Index)
+		{
+			bChanged = !Transforms[Index].Equals(Drawn[Index]);
+		}
+		if (bChanged)
+		{
+			ParkourProxies::SyncInstances(Proxies, Transforms);
+			// Reset and Append keep the capacity, assignment would resize it to fit
+			Drawn.Reset();
+			Drawn.Append(Transforms);
+			INC_DWORD_STAT(STAT_ParkourGhostComponentUpdates);
+		}
+	}
+
+	/**
+	 * Fills the level's ghost manager with looping test tracks around the first player, spread from the
+	 * near into the far LOD, so the 100 ghost budget can be checked against a runner under stat ParkourGhosts.
+	 */
+	void AddBenchmarkGhosts(const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr)
+		{
+			return;
+		}
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+
+		TActorIterator<AParkourTimeTrialGhostManager> It(World);
+		AParkourTimeTrialGhostManager* Manager = It ? *It : World->SpawnActor<AParkourTimeTrialGhostManager>();
+		const APlayerCameraManager* Camera = UGameplayStatics::GetPlayerCameraManager(World, 0);
+		const FVector Origin = Camera != nullptr ? Camera->GetCameraLocation() : FVector::ZeroVector;
+
+		for (int32 GhostIndex = 0; GhostIndex < Count; ++GhostIndex)
+		{
+			FParkourGhostTrack Track;
+			const float Radius = 500.f + 100.f * GhostIndex;
+			for (int32 KeyIndex = 0; KeyIndex <= 60; ++KeyIndex)
+			{
+				const float Angle = KeyIndex * 6.f + GhostIndex * 37.f;
+				FParkourGhostKeyframe& Keyframe = Track.Keyframes.AddDefaulted_GetRef();
+				Keyframe.Time = KeyIndex * 0.5f;
+				Keyframe.Location = Origin + FRotator(0.f, Angle, 0.f).Vector() * Radius;
+				Keyframe.Yaw = Angle + 90.f;
+			}
+			Manager->AddGhost(Track);
+		}
+		Manager->RestartPlayback();
+		UE_LOG(LogParkourGhosts, Display, TEXT("%s now plays %d ghosts"), *Manager->GetName(), Manager->GetNumGhosts());
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs BenchmarkGhostsCommand(
+		TEXT("Parkour.BenchmarkGhosts"),
+		TEXT("Adds N (default 100) looping test ghosts around the first player; read the cost with stat ParkourGhosts"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&AddBenchmarkGhosts));
+}
+
+AParkourTimeTrialGhostManager::AParkourTimeTrialGhostManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Run after the camera has been updated for this frame
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	// Engine shapes so ghosts show up without project content; swap in vertex animated meshes per level
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> NearMeshObj(TEXT("/Engine/BasicShapes/Cylinder"));
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> FarMeshObj(TEXT("/Engine/BasicShapes/Cube"));
+
+	NearProxies = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("NearProxies"));
+	NearProxies->SetupAttachment(RootComponent);
+	ParkourProxies::SetupProxyComponent(NearProxies);
+	NearProxies->SetStaticMesh(NearMeshObj.Object);
+
+	FarProxies = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("FarProxies"));
+	FarProxies->SetupAttachment(RootComponent);
+	ParkourProxies::SetupProxyComponent(FarProxies);
+	FarProxies->SetStaticMesh(FarMeshObj.Object);
+	FarProxies->SetCastShadow(false);
+
+	LODDistance = 3000.f;
+	CullDistance = 20000.f;
+	CullAngleMargin = 10.f;
+	// Runner capsule: 55 radius, 96 half height
+	ProxyScale = FVector(1.1f, 1.1f, 1.92f);
+	PlaybackTime = 0.f;
+}
+
+void AParkourTimeTrialGhostManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Nobody looks at ghosts on a dedicated server
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+int32 AParkourTimeTrialGhostManager::AddGhost(const FParkourGhostTrack& Track)
+{
+	if (Track.Keyframes.Num() == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	// Instances are handed out on the next tick, only to the ghosts that end up visible
+	Cursors.Add(0);
+	return Tracks.Add(Track);
+}
+
+void AParkourTimeTrialGhostManager::ClearGhosts()
+{
+	NearProxies->ClearInstances();
+	FarProxies->ClearInstances();
+	NearTransforms.Reset();
+	FarTransforms.Reset();
+	DrawnNearTransforms.Reset();
+	DrawnFarTransforms.Reset();
+	Cursors.Reset();
+	Tracks.Reset();
+}
+
+void AParkourTimeTrialGhostManager::RestartPlayback()
+{
+	PlaybackTime = 0.f;
+	for (int32& Cursor : Cursors)
+	{
+		Cursor = 0;
+	}
+}
+
+void AParkourTimeTrialGhostManager::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+	SCOPE_CYCLE_COUNTER(STAT_ParkourGhostTick);
+
+	if (Tracks.Num() == 0)
+	{
+		return;
+	}
+	PlaybackTime += DeltaSeconds;
+	SET_DWORD_STAT(STAT_ParkourGhosts, Tracks.Num());
+
+	const APlayerCameraManager* Camera = UGameplayStatics::GetPlayerCameraManager(this, 0);
+	if (Camera == nullptr)
+	{
+		return;
+	}
+	const FVector ViewLocation = Camera->GetCameraLocation();
+	const FVector ViewDirection = Camera->GetCameraRotation().Vector();
+	const float HalfAngle = FMath::Min(Camera->GetFOVAngle() * 0.5f + CullAngleMargin, 180.f);
+	const float CullCos = FMath::Cos(FMath::DegreesToRadians(HalfAngle));
+	const float CullDistanceSq = FMath::Square(CullDistance);
+	const float LODDistanceSq = FMath::Square(LODDistance);
+
+	NearTransforms.Reset();
+	FarTransforms.Reset();
+	for (int32 GhostIndex = 0; GhostIndex < Tracks.Num(); ++GhostIndex)
+	{
+		// Sampled even when culled so the cursor keeps up with playback
+		const FTransform Ghost = SampleGhost(GhostIndex);
+		const FVector ToGhost = Ghost.GetLocation() - ViewLocation;
+		const float DistanceSq = ToGhost.SizeSquared();
+
+		bool bVisible = DistanceSq < CullDistanceSq;
+		if (bVisible && DistanceSq > FMath::Square(AlwaysVisibleDistance))
+		{
+			bVisible = FVector::DotProduct(ToGhost, ViewDirection) >= CullCos * FMath::Sqrt(DistanceSq);
+		}
+		if (bVisible)
+		{
+			(DistanceSq < LODDistanceSq ? NearTransforms : FarTransforms).Add(Ghost);
+		}
+	}
+	SET_DWORD_STAT(STAT_ParkourGhostNearInstances, NearTransforms.Num());
+	SET_DWORD_STAT(STAT_ParkourGhostFarInstances, FarTransforms.Num());
+
+	// Finished tracks and an all culled course leave the render state alone
+	UpdateProxies(NearProxies, NearTransforms, DrawnNearTransforms);
+	UpdateProxies(FarProxies, FarTransforms, DrawnFarTransforms);
+}
+
+FTransform AParkourTimeTrialGhostManager::SampleGhost(int32 GhostIndex)
+{
+	const TArray<FParkourGhostKeyframe>& Keyframes = Tracks[GhostIndex].Keyframes;
+	int32& Cursor = Cursors[GhostIndex];
+	while (Cursor + 1 < Keyframes.Num() && Keyframes[Cursor + 1].Time <= PlaybackTime)
+	{
+		++Cursor;
+	}
+
+	const FParkourGhostKeyframe& From = Keyframes[Cursor];
+	if (Cursor + 1 == Keyframes.Num() || PlaybackTime <= From.Time)
+	{
+		return FTransform(FRotator(0.f, From.Yaw, 0.f), From.Location, ProxyScale);
+	}
+
+	const FParkourGhostKeyframe& To = Keyframes[Cursor + 1];
+	const float Alpha = (PlaybackTime - From.Time) / FMath::Max(To.Time - From.Time, KINDA_SMALL_NUMBER);
+	const float Yaw = From.Yaw + FMath::FindDeltaAngleDegrees(From.Yaw, To.Yaw) * Alpha;
+	return FTransform(FRotator(0.f, Yaw, 0.f), FMath::Lerp(From.Location, To.Location, Alpha), ProxyScale);
+}
@@ -0,0 +1,112 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ParkourTimeTrialGhostManager.generated.h"
+
+/** One recorded sample of a ghost run */
+USTRUCT(BlueprintType)
+struct FParkourGhostKeyframe
+{
+	GENERATED_BODY()
+
+	/** Seconds since the start of the run */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ghost)
+		float Time = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ghost)
+		FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ghost)
+		float Yaw = 0.f;
+};
+
+/** A full recorded run, keyframes sorted by time */
+USTRUCT(BlueprintType)
+struct FParkourGhostTrack
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ghost)
+		TArray<FParkourGhostKeyframe> Keyframes;
+};
+
+/**
+ * Renders every leaderboard ghost as an instance on a pair of instanced static mesh
+ * components instead of spawning full characters. Ghosts have no collision and no
+ * movement component; one batched tick interpolates all tracks, picks a near or far
+ * proxy by distance and only hands the visible ones to each component. Its cost shows
+ * under "stat ParkourGhosts"; Parkour.BenchmarkGhosts fills a level with test tracks.
+ */
+UCLASS()
+class AParkourTimeTrialGhostManager : public AActor
+{
+	GENERATED_BODY()
+
+	/** Detailed proxy used for ghosts closer than LODDistance */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Ghost, meta = (AllowPrivateAccess = "true"))
+	class UInstancedStaticMeshComponent* NearProxies;
+
+	/** Cheap proxy used for ghosts beyond LODDistance */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Ghost, meta = (AllowPrivateAccess = "true"))
+	class UInstancedStaticMeshComponent* FarProxies;
+
+public:
+	AParkourTimeTrialGhostManager();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Adds a ghost and returns its index */
+	UFUNCTION(BlueprintCallable, Category = Ghost)
+		int32 AddGhost(const FParkourGhostTrack& Track);
+
+	UFUNCTION(BlueprintCallable, Category = Ghost)
+		void ClearGhosts();
+
+	/** Rewinds all ghosts to the start of their runs */
+	UFUNCTION(BlueprintCallable, Category = Ghost)
+		void RestartPlayback();
+
+	UFUNCTION(BlueprintPure, Category = Ghost)
+		int32 GetNumGhosts() const { return Tracks.Num(); }
+
+	/** Distance at which ghosts switch to the far proxy */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ghost)
+		float LODDistance;
+
+	/** Ghosts further than this are not drawn at all */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ghost)
+		float CullDistance;
+
+	/** Extra degrees added to the camera's half FOV before a ghost counts as offscreen */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ghost)
+		float CullAngleMargin;
+
+	/** Scale applied to every proxy instance; the default fits the engine cylinder to a runner's capsule */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ghost)
+		FVector ProxyScale;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	/** Advances Cursors[GhostIndex] to PlaybackTime and returns the interpolated transform */
+	FTransform SampleGhost(int32 GhostIndex);
+
+	TArray<FParkourGhostTrack> Tracks;
+
+	/** Last keyframe used per ghost; playback only moves forward so sampling stays O(1) */
+	TArray<int32> Cursors;
+
+	/** Visible ghosts per component this tick; reused so the batched update doesn't allocate */
+	TArray<FTransform> NearTransforms;
+	TArray<FTransform> FarTransforms;
+
+	/** What each component was last given, so unchanged frames skip the render state update */
+	TArray<FTransform> DrawnNearTransforms;
+	TArray<FTransform> DrawnFarTransforms;
+
+	float PlaybackTime;
+};
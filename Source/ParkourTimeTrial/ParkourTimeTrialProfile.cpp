@@ -0,0 +1,33 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ParkourTimeTrialProfile.h"
+
+FOnParkourProfileChanged UParkourTimeTrialProfile::OnProfileChanged;
+
+FParkourTuning UParkourTimeTrialProfile::GetTuning() const
+{
+	if (Preset == EParkourPreset::Custom)
+	{
+		return Tuning;
+	}
+	return FParkourTuning(ParkourPresets::Get(Preset));
+}
+
+void UParkourTimeTrialProfile::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+	PresetValues = FParkourTuning(ParkourPresets::Get(Preset));
+#endif
+}
+
+#if WITH_EDITOR
+void UParkourTimeTrialProfile::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	PresetValues = FParkourTuning(ParkourPresets::Get(Preset));
+	OnProfileChanged.Broadcast(this);
+}
+#endif
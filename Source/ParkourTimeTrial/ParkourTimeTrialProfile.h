@@ -0,0 +1,149 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ParkourTimeTrialProfile.generated.h"
+
+UENUM(BlueprintType)
+enum class EParkourPreset : uint8 {
+	Custom       UMETA(DisplayName = "Custom"),
+	Casual       UMETA(DisplayName = "Casual"),
+	Standard     UMETA(DisplayName = "Standard"),
+	Competitive  UMETA(DisplayName = "Competitive"),
+};
+
+/** Plain movement tunables, so the built-in presets can live in constexpr tables */
+struct FParkourPresetValues
+{
+	float JumpHeight;
+	int32 MultiJumpMaximum;
+	float MaxWalkSpeed;
+	float RegularAirControl;
+	float DashDistance;
+	float DashCooldown;
+	float DashStop;
+	float WallRunAirControl;
+	int32 WallRunJumpLaunchMultiplier;
+	float WallRunTilt;
+	float WallRunTiltRate;
+};
+
+namespace ParkourPresets
+{
+	constexpr FParkourPresetValues Standard = { 600.f, 2, 750.f, 0.5f, 6000.f, 2.f, 0.1f, 1.f, 500, 15.f, 0.2f };
+	constexpr FParkourPresetValues Casual = { 650.f, 3, 750.f, 0.7f, 6000.f, 1.5f, 0.1f, 1.f, 500, 15.f, 0.2f };
+	/** Validated values for ranked categories; keep in sync with the leaderboard rules */
+	constexpr FParkourPresetValues Competitive = Standard;
+
+	/** Indexed by EParkourPreset; Custom falls back to Standard */
+	constexpr FParkourPresetValues Table[] = { Standard, Casual, Standard, Competitive };
+	static_assert(UE_ARRAY_COUNT(Table) == static_cast<int32>(EParkourPreset::Competitive) + 1, "Preset table out of sync with EParkourPreset");
+
+	constexpr const FParkourPresetValues& Get(EParkourPreset Preset)
+	{
+		return Table[static_cast<uint8>(Preset)];
+	}
+}
+
+/** Editable mirror of FParkourPresetValues for Custom profiles */
+USTRUCT(BlueprintType)
+struct FParkourTuning
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Jump)
+		float JumpHeight;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Jump, meta = (ClampMin = "0"))
+		int32 MultiJumpMaximum;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Movement, meta = (ClampMin = "0"))
+		float MaxWalkSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Movement, meta = (ClampMin = "0", ClampMax = "1"))
+		float RegularAirControl;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dash)
+		float DashDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dash, meta = (ClampMin = "0"))
+		float DashCooldown;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dash, meta = (ClampMin = "0"))
+		float DashStop;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = WallRun, meta = (ClampMin = "0", ClampMax = "1"))
+		float WallRunAirControl;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = WallRun)
+		int32 WallRunJumpLaunchMultiplier;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = WallRun)
+		float WallRunTilt;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = WallRun, meta = (ClampMin = "0"))
+		float WallRunTiltRate;
+
+	FParkourTuning() : FParkourTuning(ParkourPresets::Standard) {}
+
+	FParkourTuning(const FParkourPresetValues& Values)
+		: JumpHeight(Values.JumpHeight)
+		, MultiJumpMaximum(Values.MultiJumpMaximum)
+		, MaxWalkSpeed(Values.MaxWalkSpeed)
+		, RegularAirControl(Values.RegularAirControl)
+		, DashDistance(Values.DashDistance)
+		, DashCooldown(Values.DashCooldown)
+		, DashStop(Values.DashStop)
+		, WallRunAirControl(Values.WallRunAirControl)
+		, WallRunJumpLaunchMultiplier(Values.WallRunJumpLaunchMultiplier)
+		, WallRunTilt(Values.WallRunTilt)
+		, WallRunTiltRate(Values.WallRunTiltRate)
+	{
+	}
+};
+
+class UParkourTimeTrialProfile;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnParkourProfileChanged, const UParkourTimeTrialProfile*);
+
+/**
+ * Movement tuning for a course or category. Built-in presets always resolve to the
+ * compiled tables; only Custom profiles read the designer-edited values.
+ */
+UCLASS(BlueprintType)
+class UParkourTimeTrialProfile : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Parkour)
+		EParkourPreset Preset = EParkourPreset::Standard;
+
+	/** Only used by Custom profiles; kept untouched while another preset is selected */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Parkour, meta = (EditCondition = "Preset == EParkourPreset::Custom"))
+		FParkourTuning Tuning;
+
+#if WITH_EDITORONLY_DATA
+	/** What the selected built-in preset plays like, for reference only */
+	UPROPERTY(VisibleAnywhere, Transient, Category = Parkour)
+		FParkourTuning PresetValues;
+#endif
+
+	/** Competitive profiles cannot be overridden at runtime */
+	UFUNCTION(BlueprintPure, Category = Parkour)
+		bool IsLocked() const { return Preset == EParkourPreset::Competitive; }
+
+	/** Returns the values characters should use */
+	FParkourTuning GetTuning() const;
+
+	/** Fired when a profile is edited in a running session so characters can re-apply it */
+	static FOnParkourProfileChanged OnProfileChanged;
+
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+};
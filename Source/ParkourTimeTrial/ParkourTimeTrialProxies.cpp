@@ -0,0 +1,32 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ParkourTimeTrialProxies.h"
+#include "Components/InstancedStaticMeshComponent.h"
+
+namespace ParkourProxies
+{
+	void SetupProxyComponent(UInstancedStaticMeshComponent* Proxies)
+	{
+		Proxies->SetMobility(EComponentMobility::Movable);
+		Proxies->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Proxies->SetGenerateOverlapEvents(false);
+		Proxies->SetCanEverAffectNavigation(false);
+	}
+
+	void SyncInstances(UInstancedStaticMeshComponent* Proxies, const TArray<FTransform>& Transforms)
+	{
+		const int32 InstanceCount = Proxies->GetInstanceCount();
+		for (int32 Index = InstanceCount - 1; Index >= Transforms.Num(); --Index)
+		{
+			Proxies->RemoveInstance(Index);
+		}
+		for (int32 Index = InstanceCount; Index < Transforms.Num(); ++Index)
+		{
+			Proxies->AddInstanceWorldSpace(Transforms[Index]);
+		}
+		if (InstanceCount > 0 && Transforms.Num() > 0)
+		{
+			Proxies->BatchUpdateInstancesTransforms(0, Transforms, true, true, true);
+		}
+	}
+}
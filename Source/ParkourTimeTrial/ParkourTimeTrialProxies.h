@@ -0,0 +1,17 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UInstancedStaticMeshComponent;
+
+/** Helpers shared by the actors that draw runners or ghosts as instanced proxies instead of characters */
+namespace ParkourProxies
+{
+	/** Movable, without collision and ignored by navigation */
+	void SetupProxyComponent(UInstancedStaticMeshComponent* Proxies);
+
+	/** Adds or removes instances at the end to match the count, then moves the existing ones in one batch */
+	void SyncInstances(UInstancedStaticMeshComponent* Proxies, const TArray<FTransform>& Transforms);
+}
@@ -0,0 +1,108 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ParkourTimeTrialReplayWriter.h"
+#include "HAL/Event.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Compression.h"
+
+DEFINE_LOG_CATEGORY(LogParkourReplay);
+
+FParkourReplayWriter::FParkourReplayWriter(FArchive* InFile)
+	: File(InFile)
+	, SubmitIndex(0)
+	, WriteIndex(0)
+	, WorkEvent(FPlatformProcess::GetSynchEventFromPool())
+	, SlotFreedEvent(FPlatformProcess::GetSynchEventFromPool())
+	, Thread(nullptr)
+{
+	uint32 Magic = ParkourReplayFormat::Magic;
+	int32 Version = ParkourReplayFormat::Version;
+	*File << Magic << Version;
+
+	Thread = FRunnableThread::Create(this, TEXT("ParkourReplayWriter"), 0, TPri_BelowNormal);
+}
+
+FParkourReplayWriter::~FParkourReplayWriter()
+{
+	bStopping = true;
+	WorkEvent->Trigger();
+	if (Thread != nullptr)
+	{
+		Thread->WaitForCompletion();
+		delete Thread;
+	}
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	FPlatformProcess::ReturnSynchEventToPool(SlotFreedEvent);
+}
+
+void FParkourReplayWriter::Submit(float StartTime, TArray<uint8>& Data)
+{
+	if (Thread == nullptr)
+	{
+		// No worker thread on this platform, write synchronously
+		WriteChunk(StartTime, Data);
+		Data.Reset();
+		return;
+	}
+
+	FSlot& Slot = Slots[SubmitIndex];
+	while (Slot.bFull)
+	{
+		SlotFreedEvent->Wait(10);
+	}
+	Slot.StartTime = StartTime;
+	Swap(Slot.Data, Data);
+	Data.Reset();
+	Slot.bFull = true;
+	SubmitIndex = (SubmitIndex + 1) % NumSlots;
+	WorkEvent->Trigger();
+}
+
+uint32 FParkourReplayWriter::Run()
+{
+	while (!bStopping)
+	{
+		WorkEvent->Wait(100);
+		WriteFullSlots();
+	}
+	WriteFullSlots();
+	return 0;
+}
+
+void FParkourReplayWriter::WriteFullSlots()
+{
+	bool bWroteAny = false;
+	while (Slots[WriteIndex].bFull)
+	{
+		FSlot& Slot = Slots[WriteIndex];
+		WriteChunk(Slot.StartTime, Slot.Data);
+		Slot.bFull = false;
+		WriteIndex = (WriteIndex + 1) % NumSlots;
+		SlotFreedEvent->Trigger();
+		bWroteAny = true;
+	}
+	if (bWroteAny)
+	{
+		File->Flush();
+	}
+}
+
+void FParkourReplayWriter::WriteChunk(float StartTime, const TArray<uint8>& Data)
+{
+	int32 UncompressedSize = Data.Num();
+	if (UncompressedSize > ParkourReplayFormat::MaxChunkSize)
+	{
+		UE_LOG(LogParkourReplay, Error, TEXT("Replay chunk at %.2fs is %d bytes, over the format limit, dropping it"), StartTime, UncompressedSize);
+		return;
+	}
+
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, UncompressedSize);
+	CompressedBuffer.SetNumUninitialized(CompressedSize, false);
+	if (!FCompression::CompressMemory(NAME_Zlib, CompressedBuffer.GetData(), CompressedSize, Data.GetData(), UncompressedSize))
+	{
+		UE_LOG(LogParkourReplay, Error, TEXT("Failed to compress replay chunk at %.2fs, dropping it"), StartTime);
+		return;
+	}
+	*File << StartTime << UncompressedSize << CompressedSize;
+	File->Serialize(CompressedBuffer.GetData(), CompressedSize);
+}
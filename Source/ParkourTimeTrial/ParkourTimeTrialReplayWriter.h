@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogParkourReplay, Log, All);
+
+/**
+ * On-disk layout: Magic, Version, then per chunk its start time, uncompressed size,
+ * compressed size and the zlib payload.
+ */
+namespace ParkourReplayFormat
+{
+	constexpr uint32 Magic = 0x504B5250; // "PKRP"
+	constexpr int32 Version = 2;
+
+	/** Upper bound on one decompressed chunk; loaders reject anything larger instead of allocating it */
+	constexpr int32 MaxChunkSize = 64 * 1024 * 1024;
+}
+
+/**
+ * Compresses finished replay chunks and appends them to the file off the game thread.
+ * Chunks are handed over through a fixed ring of buffers that are swapped, not copied,
+ * so after warm up submitting a chunk never allocates.
+ */
+class FParkourReplayWriter : public FRunnable
+{
+public:
+	/** Takes ownership of File and writes the format header */
+	explicit FParkourReplayWriter(FArchive* InFile);
+
+	/** Waits for every submitted chunk to reach the file */
+	virtual ~FParkourReplayWriter();
+
+	/**
+	 * Swaps Data into the ring and returns an empty buffer in its place. Only blocks if the
+	 * writer has fallen a whole ring of chunks behind.
+	 */
+	void Submit(float StartTime, TArray<uint8>& Data);
+
+	virtual uint32 Run() override;
+
+private:
+	static constexpr int32 NumSlots = 4;
+
+	struct FSlot
+	{
+		float StartTime = 0.f;
+		TArray<uint8> Data;
+		FThreadSafeBool bFull;
+	};
+
+	void WriteFullSlots();
+
+	void WriteChunk(float StartTime, const TArray<uint8>& Data);
+
+	TUniquePtr<FArchive> File;
+	FSlot Slots[NumSlots];
+	/** Next slot the game thread fills */
+	int32 SubmitIndex;
+	/** Next slot the writer thread drains */
+	int32 WriteIndex;
+	FEvent* WorkEvent;
+	FEvent* SlotFreedEvent;
+	FRunnableThread* Thread;
+	FThreadSafeBool bStopping;
+	TArray<uint8> CompressedBuffer;
+};
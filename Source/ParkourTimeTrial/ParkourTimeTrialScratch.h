@@ -0,0 +1,35 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/MemStack.h"
+
+/**
+ * Per-frame scratch storage for parkour code that needs temporary containers.
+ * Containers built inside a FParkourScratchScope live on the game thread's
+ * FMemStack and are released in one go when the scope closes, so they never
+ * touch the heap once the stack's pages are warm.
+ *
+ *	FParkourScratchScope Scratch;
+ *	TParkourScratchArray<FVector> Probes;
+ */
+template<typename ElementType>
+using TParkourScratchArray = TArray<ElementType, TMemStackAllocator<>>;
+
+struct FParkourScratchScope
+{
+	FParkourScratchScope()
+		: Mark(FMemStack::Get())
+	{
+	}
+
+	/** Each scope pops its own mark exactly once */
+	FParkourScratchScope(const FParkourScratchScope&) = delete;
+	FParkourScratchScope(FParkourScratchScope&&) = delete;
+	FParkourScratchScope& operator=(const FParkourScratchScope&) = delete;
+	FParkourScratchScope& operator=(FParkourScratchScope&&) = delete;
+
+private:
+	FMemMark Mark;
+};
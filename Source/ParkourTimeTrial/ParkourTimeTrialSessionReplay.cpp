@@ -0,0 +1,521 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ParkourTimeTrialSessionReplay.h"
+#include "ParkourTimeTrialCharacter.h"
+#include "ParkourTimeTrialProjectile.h"
+#include "ParkourTimeTrialProxies.h"
+#include "ParkourTimeTrialScratch.h"
+#include "Algo/BinarySearch.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	constexpr float MaxPlaybackRate = 16.f;
+
+	/** Moves smaller than this between samples are not worth a delta entry */
+	constexpr float LocationTolerance = 0.5f;
+	constexpr float RotationTolerance = 0.5f;
+
+	/** ActorId, Kind, Location, Rotation, Velocity and flags as written by operator<< */
+	constexpr int32 SerializedStateSize = 42;
+
+	FString ResolveReplayPath(const FString& Filename)
+	{
+		FString Path = FPaths::IsRelative(Filename) ? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Replays"), Filename) : Filename;
+		if (FPaths::GetExtension(Path).IsEmpty())
+		{
+			Path += TEXT(".pkreplay");
+		}
+		return Path;
+	}
+
+	/** Reads an element count and rejects it if the rest of the archive can't hold that many elements */
+	bool ReadCount(FArchive& Ar, int32& Count, int32 ElementSize)
+	{
+		Ar << Count;
+		return !Ar.IsError() && Count >= 0 && Count <= (Ar.TotalSize() - Ar.Tell()) / ElementSize;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FParkourReplayActorState
+
+bool FParkourReplayActorState::NearlyEquals(const FParkourReplayActorState& Other) const
+{
+	return Location.Equals(Other.Location, LocationTolerance)
+		&& Rotation.Equals(Other.Rotation, RotationTolerance)
+		&& bIsWallRunning == Other.bIsWallRunning
+		&& bWallRunRightSide == Other.bWallRunRightSide
+		&& bCanDash == Other.bCanDash;
+}
+
+FArchive& operator<<(FArchive& Ar, FParkourReplayActorState& State)
+{
+	uint8 Flags = (State.bIsWallRunning ? FParkourMovementRepState::WallRunningFlag : 0)
+		| (State.bWallRunRightSide ? FParkourMovementRepState::RightSideFlag : 0)
+		| (State.bCanDash ? FParkourMovementRepState::CanDashFlag : 0);
+	Ar << State.ActorId << State.Kind << State.Location << State.Rotation << State.Velocity << Flags;
+	if (Ar.IsLoading())
+	{
+		State.bIsWallRunning = (Flags & FParkourMovementRepState::WallRunningFlag) != 0;
+		State.bWallRunRightSide = (Flags & FParkourMovementRepState::RightSideFlag) != 0;
+		State.bCanDash = (Flags & FParkourMovementRepState::CanDashFlag) != 0;
+	}
+	return Ar;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// AParkourTimeTrialSessionReplay
+
+AParkourTimeTrialSessionReplay::AParkourTimeTrialSessionReplay()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	RunnerProxies = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("RunnerProxies"));
+	RunnerProxies->SetupAttachment(RootComponent);
+	ParkourProxies::SetupProxyComponent(RunnerProxies);
+
+	ProjectileProxies = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("ProjectileProxies"));
+	ProjectileProxies->SetupAttachment(RootComponent);
+	ParkourProxies::SetupProxyComponent(ProjectileProxies);
+	ProjectileProxies->SetCastShadow(false);
+
+	SampleInterval = 1.f / 30.f;
+	KeyframeInterval = 5.f;
+	Mode = EParkourReplayMode::Idle;
+	RecordingChunkStartTime = 0.f;
+	bChunkOpen = false;
+	PlaybackChunkIndex = INDEX_NONE;
+	PlaybackDeltaIndex = 0;
+	PlaybackTime = 0.f;
+	PlaybackRate = 1.f;
+	Duration = 0.f;
+}
+
+void AParkourTimeTrialSessionReplay::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopRecording();
+	Super::EndPlay(EndPlayReason);
+}
+
+void AParkourTimeTrialSessionReplay::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (Mode == EParkourReplayMode::Recording)
+	{
+		RecordingTime += DeltaSeconds;
+		TimeSinceSample += DeltaSeconds;
+		if (TimeSinceSample >= SampleInterval)
+		{
+			// Carry the overshoot so the average rate matches SampleInterval, but don't burst after a hitch
+			TimeSinceSample = FMath::Min(TimeSinceSample - SampleInterval, SampleInterval);
+			RecordSample();
+		}
+	}
+	else if (Mode == EParkourReplayMode::Playing && PlaybackRate > 0.f && PlaybackTime < Duration)
+	{
+		PlaybackTime = FMath::Min(PlaybackTime + DeltaSeconds * PlaybackRate, Duration);
+		AdvancePlayback();
+		UpdateProxies();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Recording
+
+bool AParkourTimeTrialSessionReplay::StartRecording(const FString& Filename)
+{
+	StopRecording();
+
+	const FString Path = ResolveReplayPath(Filename);
+	FArchive* File = IFileManager::Get().CreateFileWriter(*Path);
+	if (File == nullptr)
+	{
+		UE_LOG(LogParkourReplay, Error, TEXT("Could not open %s for recording"), *Path);
+		return false;
+	}
+
+	// Recording takes over the proxies from any loaded session
+	FileData.Empty();
+	Chunks.Empty();
+	PlaybackStates.Reset();
+	PlaybackChunkIndex = INDEX_NONE;
+	RunnerProxies->ClearInstances();
+	ProjectileProxies->ClearInstances();
+
+	Writer = MakeUnique<FParkourReplayWriter>(File);
+
+	RecordedActors.Reset();
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		OnActorSpawned(*It);
+	}
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &AParkourTimeTrialSessionReplay::OnActorSpawned));
+
+	Mode = EParkourReplayMode::Recording;
+	RecordingTime = 0.f;
+	TimeSinceSample = SampleInterval;
+	RecordingData.Reset();
+	bChunkOpen = false;
+	LastRecordedStates.Reset();
+	UE_LOG(LogParkourReplay, Log, TEXT("Recording session to %s"), *Path);
+	return true;
+}
+
+void AParkourTimeTrialSessionReplay::StopRecording()
+{
+	if (Mode != EParkourReplayMode::Recording)
+	{
+		return;
+	}
+	FlushChunk();
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	RecordedActors.Reset();
+
+	// Joins the writer thread once every submitted chunk is on disk
+	Writer.Reset();
+	Mode = EParkourReplayMode::Idle;
+}
+
+void AParkourTimeTrialSessionReplay::RecordSample()
+{
+	FParkourScratchScope Scratch;
+	TParkourScratchArray<FParkourReplayActorState> Current;
+
+	for (int32 Index = RecordedActors.Num() - 1; Index >= 0; --Index)
+	{
+		// Destroyed actors drop out here; the next delta records them as removed
+		AActor* Actor = RecordedActors[Index].Get();
+		if (Actor == nullptr)
+		{
+			RecordedActors.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		FParkourReplayActorState& State = Current.AddDefaulted_GetRef();
+		State.ActorId = static_cast<int32>(Actor->GetUniqueID());
+		State.Location = Actor->GetActorLocation();
+		State.Rotation = Actor->GetActorRotation();
+		State.Velocity = Actor->GetVelocity();
+		if (const AParkourTimeTrialCharacter* Runner = Cast<AParkourTimeTrialCharacter>(Actor))
+		{
+			// The replicated state is valid on every machine, the owner's members only on the owner
+			const FParkourMovementRepState& ParkourState = Runner->GetParkourState();
+			State.Kind = EParkourReplayActorKind::Runner;
+			State.bIsWallRunning = (ParkourState.Flags & FParkourMovementRepState::WallRunningFlag) != 0;
+			State.bWallRunRightSide = (ParkourState.Flags & FParkourMovementRepState::RightSideFlag) != 0;
+			State.bCanDash = (ParkourState.Flags & FParkourMovementRepState::CanDashFlag) != 0;
+		}
+		else
+		{
+			State.Kind = EParkourReplayActorKind::Projectile;
+		}
+	}
+
+	if (bChunkOpen && RecordingTime - RecordingChunkStartTime >= KeyframeInterval)
+	{
+		FlushChunk();
+	}
+
+	// Records are serialized straight into the chunk buffer, which keeps its capacity between chunks
+	FMemoryWriter Ar(RecordingData);
+	Ar.Seek(RecordingData.Num());
+
+	// Keyframe: start time, count, states
+	if (!bChunkOpen)
+	{
+		RecordingChunkStartTime = RecordingTime;
+		int32 Count = Current.Num();
+		Ar << RecordingChunkStartTime << Count;
+		LastRecordedStates.Reset();
+		for (FParkourReplayActorState& State : Current)
+		{
+			Ar << State;
+			LastRecordedStates.Add(State.ActorId, State);
+		}
+		bChunkOpen = true;
+		return;
+	}
+
+	// Delta: time, removed count, removed ids, changed count, changed states
+	Current.Sort([](const FParkourReplayActorState& A, const FParkourReplayActorState& B) { return A.ActorId < B.ActorId; });
+
+	const int64 DeltaStart = Ar.Tell();
+	Ar << RecordingTime;
+
+	int32 RemovedCount = 0;
+	const int64 RemovedCountOffset = Ar.Tell();
+	Ar << RemovedCount;
+	for (auto It = LastRecordedStates.CreateIterator(); It; ++It)
+	{
+		int32 ActorId = It.Key();
+		if (Algo::BinarySearchBy(Current, ActorId, &FParkourReplayActorState::ActorId) == INDEX_NONE)
+		{
+			Ar << ActorId;
+			++RemovedCount;
+			It.RemoveCurrent();
+		}
+	}
+
+	int32 ChangedCount = 0;
+	const int64 ChangedCountOffset = Ar.Tell();
+	Ar << ChangedCount;
+	for (FParkourReplayActorState& State : Current)
+	{
+		FParkourReplayActorState* Last = LastRecordedStates.Find(State.ActorId);
+		if (Last == nullptr || !Last->NearlyEquals(State))
+		{
+			Ar << State;
+			++ChangedCount;
+			LastRecordedStates.Add(State.ActorId, State);
+		}
+	}
+
+	if (RemovedCount == 0 && ChangedCount == 0)
+	{
+		RecordingData.SetNum(static_cast<int32>(DeltaStart), false);
+		return;
+	}
+	const int64 DeltaEnd = Ar.Tell();
+	Ar.Seek(RemovedCountOffset);
+	Ar << RemovedCount;
+	Ar.Seek(ChangedCountOffset);
+	Ar << ChangedCount;
+	Ar.Seek(DeltaEnd);
+}
+
+void AParkourTimeTrialSessionReplay::OnActorSpawned(AActor* Actor)
+{
+	if (Actor->IsA<AParkourTimeTrialCharacter>() || Actor->IsA<AParkourTimeTrialProjectile>())
+	{
+		RecordedActors.Add(Actor);
+	}
+}
+
+void AParkourTimeTrialSessionReplay::FlushChunk()
+{
+	if (!bChunkOpen)
+	{
+		return;
+	}
+
+	// Compression and file IO run on the writer thread; this only swaps buffers
+	Writer->Submit(RecordingChunkStartTime, RecordingData);
+	bChunkOpen = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Playback
+
+bool AParkourTimeTrialSessionReplay::LoadReplay(const FString& Filename)
+{
+	StopRecording();
+	Mode = EParkourReplayMode::Idle;
+	Chunks.Reset();
+	PlaybackChunkIndex = INDEX_NONE;
+
+	const FString Path = ResolveReplayPath(Filename);
+	if (!FFileHelper::LoadFileToArray(FileData, *Path))
+	{
+		UE_LOG(LogParkourReplay, Error, TEXT("Could not read replay %s"), *Path);
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic << Version;
+	if (Reader.IsError() || Magic != ParkourReplayFormat::Magic || Version != ParkourReplayFormat::Version)
+	{
+		UE_LOG(LogParkourReplay, Error, TEXT("%s is not a version %d parkour replay"), *Path, ParkourReplayFormat::Version);
+		return false;
+	}
+
+	while (Reader.Tell() < Reader.TotalSize())
+	{
+		FChunkEntry Entry;
+		Reader << Entry.StartTime << Entry.UncompressedSize << Entry.CompressedSize;
+		Entry.Offset = Reader.Tell();
+		// A session that crashed mid-write leaves a truncated last chunk, keep what came before it
+		if (Reader.IsError()
+			|| Entry.UncompressedSize < 0 || Entry.UncompressedSize > ParkourReplayFormat::MaxChunkSize
+			|| Entry.CompressedSize < 0 || Entry.Offset + Entry.CompressedSize > Reader.TotalSize())
+		{
+			UE_LOG(LogParkourReplay, Warning, TEXT("%s is truncated or corrupt after %d chunks"), *Path, Chunks.Num());
+			break;
+		}
+		Chunks.Add(Entry);
+		Reader.Seek(Entry.Offset + Entry.CompressedSize);
+	}
+
+	if (Chunks.Num() == 0 || !LoadChunk(Chunks.Num() - 1))
+	{
+		UE_LOG(LogParkourReplay, Error, TEXT("%s contains no readable chunks"), *Path);
+		return false;
+	}
+	Duration = PlaybackChunk.Deltas.Num() > 0 ? PlaybackChunk.Deltas.Last().Time : PlaybackChunk.StartTime;
+
+	Mode = EParkourReplayMode::Playing;
+	PlaybackRate = 0.f;
+	Seek(0.f);
+	return true;
+}
+
+void AParkourTimeTrialSessionReplay::Seek(float Time)
+{
+	if (Mode != EParkourReplayMode::Playing)
+	{
+		return;
+	}
+
+	PlaybackTime = FMath::Clamp(Time, 0.f, Duration);
+	const int32 Index = FMath::Max(0, Algo::UpperBoundBy(Chunks, PlaybackTime, &FChunkEntry::StartTime) - 1);
+	if (!LoadChunk(Index))
+	{
+		return;
+	}
+	RestoreKeyframe();
+	AdvancePlayback();
+	UpdateProxies();
+}
+
+void AParkourTimeTrialSessionReplay::SetPlaybackRate(float Rate)
+{
+	PlaybackRate = FMath::Clamp(Rate, 0.f, MaxPlaybackRate);
+}
+
+void AParkourTimeTrialSessionReplay::GetPlaybackStates(TArray<FParkourReplayActorState>& OutStates) const
+{
+	PlaybackStates.GenerateValueArray(OutStates);
+}
+
+bool AParkourTimeTrialSessionReplay::LoadChunk(int32 Index)
+{
+	if (Index == PlaybackChunkIndex)
+	{
+		return true;
+	}
+
+	const FChunkEntry& Entry = Chunks[Index];
+	ChunkBuffer.SetNumUninitialized(Entry.UncompressedSize, false);
+	if (!FCompression::UncompressMemory(NAME_Zlib, ChunkBuffer.GetData(), Entry.UncompressedSize, FileData.GetData() + Entry.Offset, Entry.CompressedSize)
+		|| !DecodeChunk())
+	{
+		// Retrying every tick would only repeat the error, the moderator has to reload or seek elsewhere
+		UE_LOG(LogParkourReplay, Error, TEXT("Replay chunk %d is corrupt, stopping playback"), Index);
+		PlaybackChunkIndex = INDEX_NONE;
+		Mode = EParkourReplayMode::Idle;
+		return false;
+	}
+	PlaybackChunkIndex = Index;
+	PlaybackDeltaIndex = 0;
+	return true;
+}
+
+bool AParkourTimeTrialSessionReplay::DecodeChunk()
+{
+	FMemoryReader Reader(ChunkBuffer);
+	PlaybackChunk.Keyframe.Reset();
+	PlaybackChunk.Deltas.Reset();
+
+	int32 Count = 0;
+	Reader << PlaybackChunk.StartTime;
+	if (!ReadCount(Reader, Count, SerializedStateSize))
+	{
+		return false;
+	}
+	PlaybackChunk.Keyframe.SetNum(Count);
+	for (FParkourReplayActorState& State : PlaybackChunk.Keyframe)
+	{
+		Reader << State;
+	}
+
+	while (!Reader.IsError() && !Reader.AtEnd())
+	{
+		FDelta& Delta = PlaybackChunk.Deltas.AddDefaulted_GetRef();
+		Reader << Delta.Time;
+
+		if (!ReadCount(Reader, Count, static_cast<int32>(sizeof(int32))))
+		{
+			return false;
+		}
+		Delta.Removed.SetNum(Count);
+		for (int32& ActorId : Delta.Removed)
+		{
+			Reader << ActorId;
+		}
+
+		if (!ReadCount(Reader, Count, SerializedStateSize))
+		{
+			return false;
+		}
+		Delta.Changed.SetNum(Count);
+		for (FParkourReplayActorState& State : Delta.Changed)
+		{
+			Reader << State;
+		}
+	}
+	return !Reader.IsError();
+}
+
+void AParkourTimeTrialSessionReplay::RestoreKeyframe()
+{
+	PlaybackStates.Reset();
+	for (const FParkourReplayActorState& State : PlaybackChunk.Keyframe)
+	{
+		PlaybackStates.Add(State.ActorId, State);
+	}
+	PlaybackDeltaIndex = 0;
+}
+
+void AParkourTimeTrialSessionReplay::AdvancePlayback()
+{
+	// A later keyframe replaces everything before it, so skipped deltas never need applying
+	while (PlaybackChunkIndex + 1 < Chunks.Num() && Chunks[PlaybackChunkIndex + 1].StartTime <= PlaybackTime)
+	{
+		if (!LoadChunk(PlaybackChunkIndex + 1))
+		{
+			return;
+		}
+		RestoreKeyframe();
+	}
+
+	const TArray<FDelta>& Deltas = PlaybackChunk.Deltas;
+	while (PlaybackDeltaIndex < Deltas.Num() && Deltas[PlaybackDeltaIndex].Time <= PlaybackTime)
+	{
+		const FDelta& Delta = Deltas[PlaybackDeltaIndex];
+		for (int32 ActorId : Delta.Removed)
+		{
+			PlaybackStates.Remove(ActorId);
+		}
+		for (const FParkourReplayActorState& State : Delta.Changed)
+		{
+			PlaybackStates.Add(State.ActorId, State);
+		}
+		++PlaybackDeltaIndex;
+	}
+}
+
+void AParkourTimeTrialSessionReplay::UpdateProxies()
+{
+	RunnerTransforms.Reset();
+	ProjectileTransforms.Reset();
+	for (const TPair<int32, FParkourReplayActorState>& Pair : PlaybackStates)
+	{
+		const FParkourReplayActorState& State = Pair.Value;
+		TArray<FTransform>& Transforms = State.Kind == EParkourReplayActorKind::Runner ? RunnerTransforms : ProjectileTransforms;
+		Transforms.Emplace(State.Rotation, State.Location);
+	}
+	ParkourProxies::SyncInstances(RunnerProxies, RunnerTransforms);
+	ParkourProxies::SyncInstances(ProjectileProxies, ProjectileTransforms);
+}
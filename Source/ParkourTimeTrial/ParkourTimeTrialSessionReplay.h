@@ -0,0 +1,205 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ParkourTimeTrialReplayWriter.h"
+#include "ParkourTimeTrialSessionReplay.generated.h"
+
+UENUM(BlueprintType)
+enum class EParkourReplayActorKind : uint8 {
+	Runner       UMETA(DisplayName = "Runner"),
+	Projectile   UMETA(DisplayName = "Projectile"),
+};
+
+UENUM(BlueprintType)
+enum class EParkourReplayMode : uint8 {
+	Idle         UMETA(DisplayName = "Idle"),
+	Recording    UMETA(DisplayName = "Recording"),
+	Playing      UMETA(DisplayName = "Playing"),
+};
+
+/** Snapshot of one runner or projectile at a point in the session */
+USTRUCT(BlueprintType)
+struct FParkourReplayActorState
+{
+	GENERATED_BODY()
+
+	/** Stable for the lifetime of the recorded actor */
+	UPROPERTY(BlueprintReadOnly, Category = Replay)
+		int32 ActorId = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = Replay)
+		EParkourReplayActorKind Kind = EParkourReplayActorKind::Runner;
+
+	UPROPERTY(BlueprintReadOnly, Category = Replay)
+		FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = Replay)
+		FRotator Rotation = FRotator::ZeroRotator;
+
+	UPROPERTY(BlueprintReadOnly, Category = Replay)
+		FVector Velocity = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = Replay)
+		bool bIsWallRunning = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = Replay)
+		bool bWallRunRightSide = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = Replay)
+		bool bCanDash = false;
+
+	/** True if the two states would look the same to a reviewer */
+	bool NearlyEquals(const FParkourReplayActorState& Other) const;
+
+	friend FArchive& operator<<(FArchive& Ar, FParkourReplayActorState& State);
+};
+
+/**
+ * Records whole race sessions, every runner and projectile, and plays them back for review.
+ * Recording samples the world at a fixed rate. Every KeyframeInterval seconds it starts a new
+ * chunk holding a full snapshot followed by deltas, and a background thread compresses and
+ * appends the chunk to disk. Seeking restores the nearest earlier keyframe and fast-forwards
+ * through its deltas.
+ */
+UCLASS()
+class AParkourTimeTrialSessionReplay : public AActor
+{
+	GENERATED_BODY()
+
+	/** Playback proxies for runners */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Replay, meta = (AllowPrivateAccess = "true"))
+	class UInstancedStaticMeshComponent* RunnerProxies;
+
+	/** Playback proxies for projectiles */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Replay, meta = (AllowPrivateAccess = "true"))
+	class UInstancedStaticMeshComponent* ProjectileProxies;
+
+public:
+	AParkourTimeTrialSessionReplay();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Starts recording to Filename; relative paths go under Saved/Replays */
+	UFUNCTION(BlueprintCallable, Category = Replay)
+		bool StartRecording(const FString& Filename);
+
+	/** Flushes the last chunk and waits for the writer thread to finish */
+	UFUNCTION(BlueprintCallable, Category = Replay)
+		void StopRecording();
+
+	/** Loads a recorded session and pauses at its start */
+	UFUNCTION(BlueprintCallable, Category = Replay)
+		bool LoadReplay(const FString& Filename);
+
+	UFUNCTION(BlueprintCallable, Category = Replay)
+		void Seek(float Time);
+
+	/** Clamped to [0, 16]; 0 pauses */
+	UFUNCTION(BlueprintCallable, Category = Replay)
+		void SetPlaybackRate(float Rate);
+
+	UFUNCTION(BlueprintPure, Category = Replay)
+		float GetPlaybackTime() const { return PlaybackTime; }
+
+	UFUNCTION(BlueprintPure, Category = Replay)
+		float GetDuration() const { return Duration; }
+
+	UFUNCTION(BlueprintPure, Category = Replay)
+		EParkourReplayMode GetMode() const { return Mode; }
+
+	/** Every actor alive at the current playback time */
+	UFUNCTION(BlueprintCallable, Category = Replay)
+		void GetPlaybackStates(TArray<FParkourReplayActorState>& OutStates) const;
+
+	/** Seconds between world samples while recording */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replay)
+		float SampleInterval;
+
+	/** Seconds between full snapshots; also the length of one file chunk */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replay)
+		float KeyframeInterval;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	/** Decoded form of a delta record, only built during playback */
+	struct FDelta
+	{
+		float Time;
+		TArray<int32> Removed;
+		TArray<FParkourReplayActorState> Changed;
+	};
+
+	/** Decoded form of a chunk, only built during playback */
+	struct FChunk
+	{
+		float StartTime;
+		TArray<FParkourReplayActorState> Keyframe;
+		TArray<FDelta> Deltas;
+	};
+
+	/** Where each chunk lives in the loaded file */
+	struct FChunkEntry
+	{
+		float StartTime;
+		int64 Offset;
+		int32 UncompressedSize;
+		int32 CompressedSize;
+	};
+
+	/** Appends a keyframe or delta record for the current world straight to RecordingData */
+	void RecordSample();
+
+	/** Starts tracking runners and projectiles spawned while recording */
+	void OnActorSpawned(AActor* Actor);
+
+	/** Hands the chunk being recorded to the writer thread */
+	void FlushChunk();
+
+	/** Decompresses a chunk of the loaded file into PlaybackChunk; stops playback on failure */
+	bool LoadChunk(int32 Index);
+
+	/** Decodes ChunkBuffer into PlaybackChunk, rejecting counts the buffer can't hold */
+	bool DecodeChunk();
+
+	/** Replaces the playback state with PlaybackChunk's full snapshot */
+	void RestoreKeyframe();
+
+	/** Applies deltas and chunk boundaries up to PlaybackTime */
+	void AdvancePlayback();
+
+	void UpdateProxies();
+
+	EParkourReplayMode Mode;
+
+	float RecordingTime;
+	float TimeSinceSample;
+	/** Serialized keyframe and delta records of the open chunk; swapped with the writer on flush */
+	TArray<uint8> RecordingData;
+	float RecordingChunkStartTime;
+	bool bChunkOpen;
+	TMap<int32, FParkourReplayActorState> LastRecordedStates;
+	TUniquePtr<FParkourReplayWriter> Writer;
+	/** Runners and projectiles being recorded; actor iterators allocate, so this is kept up to date instead */
+	TArray<TWeakObjectPtr<AActor>> RecordedActors;
+	FDelegateHandle ActorSpawnedHandle;
+
+	TArray<uint8> FileData;
+	TArray<FChunkEntry> Chunks;
+	TArray<uint8> ChunkBuffer;
+	FChunk PlaybackChunk;
+	int32 PlaybackChunkIndex;
+	int32 PlaybackDeltaIndex;
+	TMap<int32, FParkourReplayActorState> PlaybackStates;
+	float PlaybackTime;
+	float PlaybackRate;
+	float Duration;
+
+	/** Instance transforms per actor kind, rebuilt in place from PlaybackStates */
+	TArray<FTransform> RunnerTransforms;
+	TArray<FTransform> ProjectileTransforms;
+};